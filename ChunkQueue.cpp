@@ -0,0 +1,74 @@
+//
+// Implements the ChunkQueue Class
+//
+
+#include "ChunkQueue.h"
+
+/**
+ * Default constructor
+ * Allocates the buffers, all initially empty
+ */
+ChunkQueue::ChunkQueue() {
+    for (int i = 0; i < ChunkCount; i ++) {
+        _chunks[i].data = new char[ChunkSize];
+        _chunks[i].size = 0;
+        _empty[i] = &_chunks[i];
+    }
+    _emptyCount = ChunkCount;
+    _fullHead = 0;
+    _fullCount = 0;
+}
+
+/**
+ * Destructor
+ * Frees the buffers
+ */
+ChunkQueue::~ChunkQueue() {
+    for (int i = 0; i < ChunkCount; i ++) {
+        delete[] _chunks[i].data;
+    }
+}
+
+/**
+ * Takes an empty buffer for filling, waiting until one is returned
+ * @return buffer with room for ChunkSize characters
+ */
+Chunk* ChunkQueue::AcquireEmpty() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _changed.wait(lock, [this] { return _emptyCount > 0; });
+    return _empty[-- _emptyCount];
+}
+
+/**
+ * Queues a filled buffer for the consumer
+ * @param chunk buffer from AcquireEmpty, size set to the bytes read
+ */
+void ChunkQueue::PushFull(Chunk* chunk) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _full[(_fullHead + _fullCount) % ChunkCount] = chunk;
+    _fullCount ++;
+    _changed.notify_all();
+}
+
+/**
+ * Takes the oldest filled buffer, waiting until one is available
+ * @return filled buffer; a size of 0 means the input has ended
+ */
+Chunk* ChunkQueue::PopFull() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _changed.wait(lock, [this] { return _fullCount > 0; });
+    Chunk* chunk = _full[_fullHead];
+    _fullHead = (_fullHead + 1) % ChunkCount;
+    _fullCount --;
+    return chunk;
+}
+
+/**
+ * Gives a consumed buffer back to the reader
+ * @param chunk buffer from PopFull
+ */
+void ChunkQueue::ReturnEmpty(Chunk* chunk) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _empty[_emptyCount ++] = chunk;
+    _changed.notify_all();
+}
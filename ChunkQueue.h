@@ -0,0 +1,47 @@
+//
+// Interface Definition for the ChunkQueue Class
+// A fixed pool of input buffers passed between a reader thread, which
+// fills them, and a parser thread, which consumes them.  Memory use is
+// bounded by the pool no matter how long the input is.
+//
+
+#ifndef CHUNKQUEUE_H
+#define CHUNKQUEUE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+struct Chunk {
+    char* data;
+    size_t size;        // 0 marks end of input
+};
+
+class ChunkQueue {
+public:
+    static const size_t ChunkSize = 64 * 1024;
+    static const int ChunkCount = 4;
+
+    ChunkQueue();
+    ~ChunkQueue();
+
+    ChunkQueue(const ChunkQueue&) = delete;
+    const ChunkQueue& operator=(const ChunkQueue&) = delete;
+
+    Chunk* AcquireEmpty();
+    void PushFull(Chunk* chunk);
+    Chunk* PopFull();
+    void ReturnEmpty(Chunk* chunk);
+
+private:
+    Chunk _chunks[ChunkCount];
+    Chunk* _empty[ChunkCount];
+    Chunk* _full[ChunkCount];
+    int _emptyCount;
+    int _fullHead;
+    int _fullCount;
+    std::mutex _mutex;
+    std::condition_variable _changed;
+};
+
+#endif //CHUNKQUEUE_H
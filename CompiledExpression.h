@@ -0,0 +1,484 @@
+//
+// Interface Definition and Implementation for the CompiledExpression Class
+// A header-only, constexpr front end that parses and simplifies a postfix
+// string literal at compile time and stores the result as bytecode.  It
+// follows the simplification rules documented in the README rather than
+// the exact output of ExpressionTree::SimplifyTree: a product is always a
+// real number * exp node, never a joined-text leaf, so "x x +" gives 2*x
+// where SimplifyTree prints 2x, and "0 x -" gives -1*x where it prints -x.
+// Subtrees are compared structurally, and a number times a product that
+// already starts with a number is folded, so "x 2 * 3 *" gives 6*x.
+// Sums are not reassociated: "x 2 + 3 +" stays (x+2)+3.  A constant that
+// overflows long long while folding makes Valid() false; Evaluate does
+// not check for overflow.  CompiledExpressionCheck.cpp pins this
+// behaviour down with static_asserts.
+//
+//     constexpr auto expr = CompilePostfix("x 2 3 + * 0 +");
+//     static_assert(expr.Valid(), "bad postfix");
+//     const long long x[] = { 7 };
+//     long long y = expr.Evaluate(x);      // 35, no parsing or allocation at run time
+//
+
+#ifndef COMPILEDEXPRESSION_H
+#define COMPILEDEXPRESSION_H
+
+#include <climits>
+#include <cstddef>
+#include <string>
+
+enum CompiledNodeType {
+    NodeOperator,
+    NodeNumber,
+    NodeVariable
+};
+
+enum CompiledOp {
+    OpPushNumber,
+    OpPushVariable,
+    OpAdd,
+    OpSubtract,
+    OpMultiply
+};
+
+struct CompiledInstruction {
+    CompiledOp op = OpPushNumber;
+    long long operand = 0;      // number, or variable index
+};
+
+struct CompiledNode {
+    CompiledNodeType type = NodeNumber;
+    char op = 0;
+    long long value = 0;        // number, or variable index
+    int left = -1;
+    int right = -1;
+};
+
+struct CompiledVariable {
+    size_t start = 0;           // position of the name in the source text
+    size_t length = 0;
+};
+
+template <size_t N>
+class CompiledExpression {
+public:
+    static constexpr size_t Capacity = 2 * N + 1;
+
+    constexpr explicit CompiledExpression(const char (&postfix)[N]);
+
+    constexpr bool Valid() const { return _error == nullptr; };
+    constexpr const char* Error() const { return _error; };
+
+    constexpr size_t CodeSize() const { return _codeSize; };
+    constexpr const CompiledInstruction& Code(size_t position) const { return _code[position]; };
+
+    constexpr size_t VariableCount() const { return _variableCount; };
+    constexpr int VariableIndex(const char* name) const;
+    std::string VariableName(size_t index) const;
+
+    constexpr long long Evaluate(const long long* values) const;
+    std::string ToString() const { return Valid() ? ToString(_root, false) : std::string(); };
+
+private:
+    static constexpr bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; };
+    static constexpr bool IsDigit(char c) { return c >= '0' && c <= '9'; };
+    static constexpr bool IsAlpha(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); };
+
+    constexpr void Parse(size_t length);
+    constexpr int FindVariable(size_t start, size_t length);
+    constexpr int NewNumber(long long value);
+    constexpr int NewVariable(int index);
+    constexpr int NewOperator(char op, int left, int right);
+    constexpr int Combine(char op, int left, int right);
+    constexpr long long Fold(char op, long long a, long long b);
+    constexpr void SplitNumTimesExp(int node, long long& c, int& exp) const;
+    constexpr bool IsSameTree(int tree1, int tree2) const;
+    constexpr bool IsNumber(int node, long long value) const;
+    constexpr void Emit(int node);
+    std::string ToString(int node, bool fNeedOuterParen) const;
+
+    char _text[N] = {};
+    CompiledNode _nodes[Capacity] = {};
+    CompiledInstruction _code[Capacity] = {};
+    CompiledVariable _variables[N] = {};
+    size_t _nodeCount = 0;
+    size_t _codeSize = 0;
+    size_t _variableCount = 0;
+    int _root = -1;
+    const char* _error = nullptr;
+};
+
+/**
+ * Compiles a postfix string literal
+ * @param postfix the literal, tokens separated by whitespace
+ * @return compiled expression; check Valid() with a static_assert
+ */
+template <size_t N>
+constexpr CompiledExpression<N> CompilePostfix(const char (&postfix)[N]) {
+    return CompiledExpression<N>(postfix);
+}
+
+/**
+ * Constructor
+ * Copies the text, builds and simplifies the tree and emits bytecode
+ * @param postfix string representation of tree
+ */
+template <size_t N>
+constexpr CompiledExpression<N>::CompiledExpression(const char (&postfix)[N]) {
+    size_t length = 0;
+    while (length < N && postfix[length] != '\0') {
+        _text[length] = postfix[length];
+        length ++;
+    }
+    Parse(length);
+    if (_error == nullptr) {
+        Emit(_root);
+    }
+}
+
+/**
+ * Builds the tree with an operand stack, the same way as
+ * ExpressionTree::BuildExpressionTree, simplifying each operator as it
+ * is reduced so the finished tree is already simplified
+ * @param length number of characters of text
+ */
+template <size_t N>
+constexpr void CompiledExpression<N>::Parse(size_t length) {
+    int stack[N] = {};
+    size_t stackSize = 0;
+    size_t position = 0;
+
+    while (_error == nullptr && position < length) {
+        if (IsSpace(_text[position])) {
+            position ++;
+            continue;
+        }
+        size_t start = position;
+        while (position < length && !IsSpace(_text[position])) {
+            position ++;
+        }
+        size_t tokenLength = position - start;
+        char first = _text[start];
+
+        if (IsDigit(first)) {
+            long long value = 0;
+            for (size_t i = start; i < position && _error == nullptr; i ++) {
+                if (!IsDigit(_text[i])) {
+                    _error = "input token not valid";
+                }
+                else if (i - start >= 18) {
+                    _error = "number literal too large";
+                }
+                else {
+                    value = 10 * value + (_text[i] - '0');
+                }
+            }
+            if (_error == nullptr) {
+                stack[stackSize ++] = NewNumber(value);
+            }
+        }
+        else if (IsAlpha(first)) {
+            for (size_t i = start; i < position; i ++) {
+                if (!IsAlpha(_text[i]) && !IsDigit(_text[i])) {
+                    _error = "input token not valid";
+                }
+            }
+            if (_error == nullptr) {
+                stack[stackSize ++] = NewVariable(FindVariable(start, tokenLength));
+            }
+        }
+        else if (tokenLength == 1 && (first == '+' || first == '-' || first == '*')) {
+            if (stackSize < 2) {
+                _error = "operator found with no operands";
+            }
+            else {
+                int right = stack[-- stackSize];
+                int left = stack[-- stackSize];
+                stack[stackSize ++] = Combine(first, left, right);
+            }
+        }
+        else {
+            _error = "input token not valid";
+        }
+    }
+    if (_error == nullptr && stackSize != 1) {
+        _error = "postfix expression is not valid";
+    }
+    if (_error == nullptr) {
+        _root = stack[0];
+    }
+}
+
+/**
+ * Looks up a variable name, adding it if it is new
+ * @param start position of the name in the text
+ * @param length length of the name
+ * @return dense index of the variable, in order of first appearance
+ */
+template <size_t N>
+constexpr int CompiledExpression<N>::FindVariable(size_t start, size_t length) {
+    for (size_t index = 0; index < _variableCount; index ++) {
+        if (_variables[index].length == length) {
+            size_t i = 0;
+            while (i < length && _text[_variables[index].start + i] == _text[start + i]) {
+                i ++;
+            }
+            if (i == length) {
+                return (int) index;
+            }
+        }
+    }
+    _variables[_variableCount].start = start;
+    _variables[_variableCount].length = length;
+    return (int) _variableCount ++;
+}
+
+/**
+ * Node allocation.  A token adds at most three nodes, and takes at least
+ * two characters of the literal counting its separator or the null, so
+ * Capacity is never exceeded.
+ */
+template <size_t N>
+constexpr int CompiledExpression<N>::NewNumber(long long value) {
+    _nodes[_nodeCount].type = NodeNumber;
+    _nodes[_nodeCount].value = value;
+    return (int) _nodeCount ++;
+}
+
+template <size_t N>
+constexpr int CompiledExpression<N>::NewVariable(int index) {
+    _nodes[_nodeCount].type = NodeVariable;
+    _nodes[_nodeCount].value = index;
+    return (int) _nodeCount ++;
+}
+
+template <size_t N>
+constexpr int CompiledExpression<N>::NewOperator(char op, int left, int right) {
+    _nodes[_nodeCount].type = NodeOperator;
+    _nodes[_nodeCount].op = op;
+    _nodes[_nodeCount].left = left;
+    _nodes[_nodeCount].right = right;
+    return (int) _nodeCount ++;
+}
+
+/**
+ * Builds left op right, applying the README's simplification rules.  Both
+ * subtrees are already simplified.
+ * - constants are folded
+ * - 0 + exp, exp + 0, exp - 0 reduce to exp; 0 - exp becomes -1 * exp
+ * - 1 * exp, exp * 1 reduce to exp; 0 * exp, exp * 0 reduce to 0
+ * - exp * number is changed to number * exp, and number * (c * exp)
+ *   is folded to (number*c) * exp
+ * - (c1 * exp) + (c2 * exp) becomes (c1+c2) * exp, likewise for -,
+ *   where a bare exp counts as 1 * exp, so exp + exp is 2 * exp and
+ *   exp - exp is 0
+ * @return index of the resulting node
+ */
+template <size_t N>
+constexpr int CompiledExpression<N>::Combine(char op, int left, int right) {
+    if (_nodes[left].type == NodeNumber && _nodes[right].type == NodeNumber) {
+        long long a = _nodes[left].value;
+        long long b = _nodes[right].value;
+        return NewNumber(Fold(op, a, b));
+    }
+    if (op == '*') {
+        if (IsNumber(left, 0) || IsNumber(right, 0)) {
+            return NewNumber(0);
+        }
+        if (IsNumber(left, 1)) {
+            return right;
+        }
+        if (IsNumber(right, 1)) {
+            return left;
+        }
+        if (_nodes[left].type == NodeNumber || _nodes[right].type == NodeNumber) {
+            int number = _nodes[left].type == NodeNumber ? left : right;
+            int exp = number == left ? right : left;
+            long long c = 1;
+            int inner = exp;
+            SplitNumTimesExp(exp, c, inner);
+            if (inner != exp) {
+                return Combine('*', NewNumber(Fold('*', _nodes[number].value, c)), inner);
+            }
+            return NewOperator('*', number, exp);
+        }
+        return NewOperator('*', left, right);
+    }
+
+    if (IsNumber(right, 0)) {
+        return left;
+    }
+    if (IsNumber(left, 0)) {
+        return op == '+' ? right : Combine('*', NewNumber(-1), right);
+    }
+
+    long long c1 = 1;
+    long long c2 = 1;
+    int exp1 = left;
+    int exp2 = right;
+    SplitNumTimesExp(left, c1, exp1);
+    SplitNumTimesExp(right, c2, exp2);
+    if (IsSameTree(exp1, exp2)) {
+        return Combine('*', NewNumber(Fold(op, c1, c2)), exp1);
+    }
+    return NewOperator(op, left, right);
+}
+
+/**
+ * Folds two constants, failing the compile instead of overflowing
+ * @param op the operator, +, - or *
+ * @return a op b, or 0 with the error set if that is out of range
+ */
+template <size_t N>
+constexpr long long CompiledExpression<N>::Fold(char op, long long a, long long b) {
+    bool overflow = false;
+    if (op == '+') {
+        overflow = (b > 0 && a > LLONG_MAX - b) || (b < 0 && a < LLONG_MIN - b);
+    }
+    else if (op == '-') {
+        overflow = (b < 0 && a > LLONG_MAX + b) || (b > 0 && a < LLONG_MIN + b);
+    }
+    else if (a != 0 && b != 0) {
+        overflow = a > 0 ? (b > 0 ? a > LLONG_MAX / b : b < LLONG_MIN / a)
+                         : (b > 0 ? a < LLONG_MIN / b : b < LLONG_MAX / a);
+    }
+    if (overflow) {
+        _error = "constant out of range";
+        return 0;
+    }
+    return op == '+' ? a + b : op == '*' ? a * b : a - b;
+}
+
+/**
+ * Splits a node of the form number * exp
+ * @param node node to split
+ * @param c receives the number, unchanged if node is not of that form
+ * @param exp receives exp, unchanged if node is not of that form
+ */
+template <size_t N>
+constexpr void CompiledExpression<N>::SplitNumTimesExp(int node, long long& c, int& exp) const {
+    if (_nodes[node].type == NodeOperator && _nodes[node].op == '*' && _nodes[_nodes[node].left].type == NodeNumber) {
+        c = _nodes[_nodes[node].left].value;
+        exp = _nodes[node].right;
+    }
+}
+
+/**
+ * Determine whether two subtrees represent the same expression
+ */
+template <size_t N>
+constexpr bool CompiledExpression<N>::IsSameTree(int tree1, int tree2) const {
+    const CompiledNode& a = _nodes[tree1];
+    const CompiledNode& b = _nodes[tree2];
+    if (a.type != b.type) {
+        return false;
+    }
+    if (a.type != NodeOperator) {
+        return a.value == b.value;
+    }
+    return a.op == b.op && IsSameTree(a.left, b.left) && IsSameTree(a.right, b.right);
+}
+
+template <size_t N>
+constexpr bool CompiledExpression<N>::IsNumber(int node, long long value) const {
+    return _nodes[node].type == NodeNumber && _nodes[node].value == value;
+}
+
+/**
+ * Appends the postfix bytecode for a subtree
+ */
+template <size_t N>
+constexpr void CompiledExpression<N>::Emit(int node) {
+    const CompiledNode& tree = _nodes[node];
+    if (tree.type == NodeOperator) {
+        Emit(tree.left);
+        Emit(tree.right);
+        _code[_codeSize].op = tree.op == '+' ? OpAdd : tree.op == '-' ? OpSubtract : OpMultiply;
+    }
+    else {
+        _code[_codeSize].op = tree.type == NodeNumber ? OpPushNumber : OpPushVariable;
+        _code[_codeSize].operand = tree.value;
+    }
+    _codeSize ++;
+}
+
+/**
+ * Returns the index of a variable, for filling in the Evaluate array
+ * @param name variable name
+ * @return index, or -1 if the expression does not use the variable
+ */
+template <size_t N>
+constexpr int CompiledExpression<N>::VariableIndex(const char* name) const {
+    for (size_t index = 0; index < _variableCount; index ++) {
+        size_t i = 0;
+        while (i < _variables[index].length && name[i] == _text[_variables[index].start + i]) {
+            i ++;
+        }
+        if (i == _variables[index].length && name[i] == '\0') {
+            return (int) index;
+        }
+    }
+    return -1;
+}
+
+template <size_t N>
+std::string CompiledExpression<N>::VariableName(size_t index) const {
+    return std::string(_text + _variables[index].start, _variables[index].length);
+}
+
+/**
+ * Runs the bytecode
+ * @param values variable values indexed as by VariableIndex, may be
+ * nullptr if VariableCount() is 0
+ * @return value of the expression
+ */
+template <size_t N>
+constexpr long long CompiledExpression<N>::Evaluate(const long long* values) const {
+    long long stack[Capacity] = {};
+    size_t stackSize = 0;
+
+    for (size_t i = 0; i < _codeSize; i ++) {
+        const CompiledInstruction& instruction = _code[i];
+        if (instruction.op == OpPushNumber) {
+            stack[stackSize ++] = instruction.operand;
+        }
+        else if (instruction.op == OpPushVariable) {
+            stack[stackSize ++] = values[instruction.operand];
+        }
+        else {
+            long long right = stack[-- stackSize];
+            long long left = stack[stackSize - 1];
+            stack[stackSize - 1] = instruction.op == OpAdd ? left + right
+                                 : instruction.op == OpSubtract ? left - right : left * right;
+        }
+    }
+    return stackSize == 1 ? stack[0] : 0;
+}
+
+/**
+ * Produce an infix representation, parenthesized like ExpressionTree's.
+ * Products print as number*exp, e.g. 2*x where SimplifyTree prints 2x.
+ */
+template <size_t N>
+std::string CompiledExpression<N>::ToString(int node, bool fNeedOuterParen) const {
+    const CompiledNode& tree = _nodes[node];
+    std::string s;
+
+    if (NodeOperator == tree.type) {
+        if (fNeedOuterParen) {
+            s += "(";
+        }
+        s += ToString(tree.left, true);
+        s += tree.op;
+        s += ToString(tree.right, true);
+        if (fNeedOuterParen) {
+            s += ")";
+        }
+    } else if (NodeNumber == tree.type) {
+        s += std::to_string(tree.value);
+    } else {
+        s += VariableName(tree.value);
+    }
+    return s;
+}
+
+#endif //COMPILEDEXPRESSION_H
@@ -0,0 +1,53 @@
+//
+// Compile-time checks for CompiledExpression.h
+// Nothing here runs; the build fails if any assertion does not hold.
+//
+
+#include "CompiledExpression.h"
+
+// Constant folding
+constexpr auto arithmetic = CompilePostfix("2 3 4 5 * + -");
+static_assert(arithmetic.Valid() && arithmetic.CodeSize() == 1, "constants fold to one number");
+static_assert(arithmetic.Evaluate(nullptr) == -21, "2-(3+(4*5))");
+
+// Multiplication by 0 and 1, adding or subtracting 0
+constexpr auto times0 = CompilePostfix("0 x z - *");
+static_assert(times0.CodeSize() == 1 && times0.Evaluate(nullptr) == 0, "0*(x-z) is 0");
+constexpr auto times1 = CompilePostfix("1 x y + *");
+static_assert(times1.CodeSize() == 3, "1*(x+y) is x+y");
+constexpr auto plus0 = CompilePostfix("x y + 2 2 - +");
+static_assert(plus0.CodeSize() == 3, "(x+y)+(2-2) is x+y");
+
+// Subtraction of equal quantities, compared structurally
+constexpr auto same = CompilePostfix("x y + z * x y + z * -");
+static_assert(same.CodeSize() == 1 && same.Evaluate(nullptr) == 0, "exp-exp is 0");
+constexpr auto different = CompilePostfix("x y + x z + -");
+static_assert(different.CodeSize() == 7, "(x+y)-(x+z) does not simplify");
+
+// Customary order and the distributive law
+constexpr auto order = CompilePostfix("x 2 *");
+static_assert(order.Code(0).op == OpPushNumber && order.Code(0).operand == 2, "2*x");
+constexpr auto doubled = CompilePostfix("x x +");
+static_assert(doubled.CodeSize() == 3 && doubled.Code(0).operand == 2, "x+x is 2*x");
+constexpr auto negated = CompilePostfix("0 x -");
+static_assert(negated.CodeSize() == 3 && negated.Code(0).operand == -1, "0-x is -1*x");
+constexpr auto distributed = CompilePostfix("x y + 9 * x y + 7 * -");
+constexpr long long xy[] = { 4, 6 };
+static_assert(distributed.CodeSize() == 5 && distributed.Evaluate(xy) == 20, "2*(x+y)");
+constexpr auto nested = CompilePostfix("x 2 * 3 * x 6 * -");
+static_assert(nested.CodeSize() == 1 && nested.Evaluate(nullptr) == 0, "3*(2*x) is 6*x");
+constexpr auto nestedOne = CompilePostfix("0 0 x - -");
+static_assert(nestedOne.CodeSize() == 1 && nestedOne.Code(0).op == OpPushVariable, "-1*(-1*x) is x");
+
+// Variables and evaluation
+constexpr auto embedded = CompilePostfix("x 2 3 + * 0 +");
+constexpr long long x7[] = { 7 };
+static_assert(embedded.VariableCount() == 1 && embedded.VariableIndex("x") == 0, "one variable");
+static_assert(embedded.Evaluate(x7) == 35, "5*x at x=7");
+
+// Errors
+static_assert(!CompilePostfix("2 3 /").Valid(), "invalid token");
+static_assert(!CompilePostfix("2 +").Valid(), "missing operand");
+static_assert(!CompilePostfix("x x").Valid(), "too many operands");
+static_assert(!CompilePostfix("999999999999999999 999999999999999999 *").Valid(), "constant overflow");
+static_assert(!CompilePostfix("0 999999999999999999 - 10 *").Valid(), "constant overflow below LLONG_MIN");
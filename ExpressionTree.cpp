@@ -4,27 +4,22 @@
 // Date: 10/27/2021
 //
 
+#include <climits>
 #include <iostream>
-#include <sstream>
 using std::cout;
 using std::endl;
 using std::string;
-using std::stringstream;
 
-#include "Stack.h"
 #include "ExpressionTree.h"
-
-// Token testing routines
-bool IsNumber(string token);
-bool IsVariable(string token);
-bool IsOperator(string token);
+#include "Tokens.h"
 
 /**
  * Default constructor
- * Creates an "null tree"
+ * Creates an "null tree" that interns variables in the global symbol table
  */
 ExpressionTree::ExpressionTree() {
     _root = nullptr;
+    _symbols = &SymbolTable::Global();
 }
 
 /**
@@ -35,60 +30,102 @@ ExpressionTree::~ExpressionTree() {
     delete _root;
 }
 
+/**
+ * Copy Constructor
+ * Creates a deep copy of the tree
+ * @param other the tree to be copied
+ */
+ExpressionTree::ExpressionTree(const ExpressionTree& other) {
+    _root = CopyTree(other._root);
+    _limits = other._limits;
+    _symbols = other._symbols;
+}
+
+/**
+ * Copy assignment operator
+ * Copies the rhs, then swaps the copy's tree with this one so the old
+ * tree is freed when the copy goes away
+ * @param rhs the tree to be copied into this
+ * @return this to enable cascade assignments
+ */
+const ExpressionTree& ExpressionTree::operator=(const ExpressionTree& rhs) {
+    if (this != &rhs) {
+        ExpressionTree copy(rhs);
+        TreeNode* swapRoot;
+
+        swapRoot = _root;
+        _root = copy._root;
+        copy._root = swapRoot;
+        _limits = rhs._limits;
+        _symbols = rhs._symbols;
+    }
+    return *this;
+}
+
+/**
+ * Recursively copies a tree structure
+ * @param tree tree to copy, may be nullptr
+ * @return newly allocated copy
+ */
+TreeNode* ExpressionTree::CopyTree(TreeNode* tree) const {
+    if (tree == nullptr) {
+        return nullptr;
+    }
+    TreeNode* copy;
+    if (tree->Symbols() != nullptr) {
+        copy = new TreeNode(tree->Symbols(), tree->Symbol());
+    }
+    else {
+        copy = new TreeNode(tree->Type(), tree->Data());
+    }
+    copy->SetLeft(CopyTree(tree->Left()));
+    copy->SetRight(CopyTree(tree->Right()));
+    return copy;
+}
+
 /**
  * Build an expression tree from its postfix representation
- * In case of error the stack is cleaned up.  Because it contains
- * pointers to TreeNodes, if any are left on the stack they must be
- * explicitly deleted
+ * The string is handed to a PostfixBuilder in one piece; the limits set
+ * with SetLimits are checked as each token is scanned.
  * @param postfix string representation of tree
  * @return true if postfix valid and tree was built, false otherwise
  */
 bool ExpressionTree::BuildExpressionTree(const string& postfix) {
-    stringstream ss(postfix);
-    string token;
-    Stack<TreeNode*> expTree;
-    TreeNode* nodeToDelete;
-
-    while(ss >> token) {
-        if (IsNumber(token) || IsVariable(token)) {
-            if (IsNumber(token)) { expTree.Push(new TreeNode(::NumberOperand, token)); }
-            else { expTree.Push(new TreeNode(::VariableOperand, token)); }
-        }
-        else if (IsOperator(token)) {
-            if (expTree.Size() < 2) {
-                cout << "ERROR: operator found with no operands" << endl;
-                for (int i = expTree.Size(); i > 0; i--) {
-                    nodeToDelete = expTree.Pop();
-                    delete nodeToDelete;
-                }
-                return false;
-            }
-            TreeNode* expression = new TreeNode(Operator, token);
-            expression->SetRight(expTree.Pop());
-            expression->SetLeft(expTree.Pop());
-            expTree.Push(expression);
-        }
-        else {
-            cout << "ERROR: input " << token << " not valid" << endl;
-            for (int i = expTree.Size(); i > 0; i--) {
-                nodeToDelete = expTree.Pop();
-                delete nodeToDelete;
-            }
-            return false;
-        }
-    }
-    if (expTree.Size() != 1) {
-        cout << "ERROR: postfix expression is not valid" << endl;
-        for (int i = expTree.Size(); i > 0; i--) {
-            nodeToDelete = expTree.Pop();
-            delete nodeToDelete;
-        }
+    PostfixBuilder builder(_limits, _symbols);
+
+    builder.Feed(postfix.data(), postfix.length());
+    return BuildExpressionTree(builder);
+}
+
+/**
+ * Finish an incremental build and take ownership of the tree
+ * The builder is left empty; call Reset on it before reusing it.
+ * @param builder builder that has been fed the whole expression
+ * @return true if the input was valid and tree was built, false otherwise
+ */
+bool ExpressionTree::BuildExpressionTree(PostfixBuilder& builder) {
+    if (!builder.Finish()) {
+        cout << "ERROR: " << builder.Error() << endl;
         return false;
     }
-    _root = expTree.Pop();
+    delete _root;
+    _root = builder.Release();
     return true;
 }
 
+/**
+ * Makes a new variable leaf holding the same data as source, sharing its
+ * symbol id when source is an interned variable
+ * @param source node whose data is copied
+ * @return newly allocated leaf
+ */
+static TreeNode* VariableLeaf(const TreeNode* source) {
+    if (source->Symbols() != nullptr) {
+        return new TreeNode(source->Symbols(), source->Symbol());
+    }
+    return new TreeNode(VariableOperand, source->Data());
+}
+
 /**
  * Recursively simplify an expression stored in an expression tree.  THe following simplications are performed
  * - Addition, multiplication, and subtraction of constants is performed reducing the subtree to a leaf containing a number
@@ -132,12 +169,12 @@ TreeNode* ExpressionTree::SimplifyTree(TreeNode* tree) {
             return new TreeNode(NumberOperand, "0");
         }
         else if (tree->Left()->IsOne()) {
-            TreeNode* tmp = new TreeNode(VariableOperand, tree->Right()->Data());
+            TreeNode* tmp = VariableLeaf(tree->Right());
             delete tree;
             return tmp;
         }
         else if (tree->Right()->IsOne()) {
-            TreeNode* tmp = new TreeNode(VariableOperand, tree->Left()->Data());
+            TreeNode* tmp = VariableLeaf(tree->Left());
             delete tree;
             return tmp;
         }
@@ -153,23 +190,23 @@ TreeNode* ExpressionTree::SimplifyTree(TreeNode* tree) {
         }
     }
     else if (tree->Data() == "+") {
-        if (tree->Left()->Data() == tree->Right()->Data()) {
+        if (tree->Left()->SameData(tree->Right())) {
             TreeNode* tmp = new TreeNode(VariableOperand, "2" + tree->Left()->Data());
             delete tree;
             return tmp;
         }
         else if (tree->Left()->IsZero()) {
-            TreeNode* tmp = new TreeNode(VariableOperand, tree->Right()->Data());
+            TreeNode* tmp = VariableLeaf(tree->Right());
             delete tree;
             return tmp;
         } else if (tree->Right()->IsZero()) {
-            TreeNode* tmp = new TreeNode(VariableOperand, tree->Left()->Data());
+            TreeNode* tmp = VariableLeaf(tree->Left());
             delete tree;
             return tmp;
         }
     }
     else if (tree->Data() == "-") {
-        if (tree->Left()->Data() == tree->Right()->Data()) {
+        if (tree->Left()->SameData(tree->Right())) {
             delete tree;
             return new TreeNode(NumberOperand, "0");
         }
@@ -178,7 +215,7 @@ TreeNode* ExpressionTree::SimplifyTree(TreeNode* tree) {
             delete tree;
             return tmp;
         } else if (tree->Right()->IsZero()) {
-            TreeNode* tmp = new TreeNode(VariableOperand, tree->Left()->Data());
+            TreeNode* tmp = VariableLeaf(tree->Left());
             delete tree;
             return tmp;
         }
@@ -199,6 +236,290 @@ bool ExpressionTree::IsSameTree(TreeNode* tree1, TreeNode* tree2) const {
     return false;
 }
 
+/**
+ * Rewrites polynomial subtrees into Horner form with common powers of the
+ * variable factored out, e.g. x*x*x+3*x*x+2*x becomes x*(2+x*(3+x)).
+ * Works in a single post-order pass: each node combines its children's
+ * polynomials, and a maximal polynomial subtree is rewritten only when
+ * the Horner form needs strictly fewer operations.
+ */
+void ExpressionTree::Optimize() {
+    if (_root == nullptr) {
+        return;
+    }
+    Polynomial* poly;
+    size_t operations;
+
+    _root = OptimizeTree(_root, poly, operations);
+    _root = RewritePolynomial(_root, poly, operations);
+}
+
+/**
+ * Post-order step of Optimize
+ * @param tree subtree to optimize, ownership passes to this method
+ * @param poly receives the subtree's polynomial (caller deletes it), or
+ * nullptr if the subtree is not a polynomial in one variable
+ * @param operations receives the operation count of the returned subtree
+ * @return the optimized subtree
+ */
+TreeNode* ExpressionTree::OptimizeTree(TreeNode* tree, Polynomial*& poly, size_t& operations) {
+    if (tree->Type() != Operator) {
+        poly = LeafPolynomial(tree);
+        operations = CountOperations(tree, false);
+        return tree;
+    }
+
+    Polynomial* left;
+    Polynomial* right;
+    size_t leftOperations;
+    size_t rightOperations;
+    tree->SetLeft(OptimizeTree(tree->Left(), left, leftOperations));
+    tree->SetRight(OptimizeTree(tree->Right(), right, rightOperations));
+    operations = leftOperations + rightOperations + 1;
+
+    poly = CombinePolynomials(tree->Data(), left, right);
+    if (poly != nullptr) {
+        delete left;
+        delete right;
+        return tree;
+    }
+
+    // Not a polynomial, so each polynomial child is as large as it gets
+    tree->SetLeft(RewritePolynomial(tree->Left(), left, leftOperations));
+    tree->SetRight(RewritePolynomial(tree->Right(), right, rightOperations));
+    operations = leftOperations + rightOperations + 1;
+
+    // Drop operations that became trivial once a child folded to 0 or 1
+    TreeNode* keep = nullptr;
+    if (tree->Data() == "*" && (tree->Left()->IsZero() || tree->Right()->IsZero())) {
+        delete tree;
+        operations = 0;
+        return new TreeNode(NumberOperand, "0");
+    }
+    if ((tree->Data() == "*" && tree->Left()->IsOne()) || (tree->Data() == "+" && tree->Left()->IsZero())) {
+        keep = tree->Right();
+        tree->SetRight(nullptr);
+        operations = rightOperations;
+    }
+    else if ((tree->Data() == "*" && tree->Right()->IsOne()) || (tree->Data() != "*" && tree->Right()->IsZero())) {
+        keep = tree->Left();
+        tree->SetLeft(nullptr);
+        operations = leftOperations;
+    }
+    if (keep != nullptr) {
+        delete tree;
+        return keep;
+    }
+    return tree;
+}
+
+/**
+ * Replaces a polynomial subtree with its Horner form if that is cheaper
+ * @param tree subtree, ownership passes to this method
+ * @param poly its polynomial or nullptr; deleted by this method
+ * @param operations operation count of tree, updated if it is replaced
+ * @return the cheaper subtree
+ */
+TreeNode* ExpressionTree::RewritePolynomial(TreeNode* tree, Polynomial* poly, size_t& operations) {
+    if (poly == nullptr) {
+        return tree;
+    }
+    TreeNode* horner = BuildHorner(*poly);
+    size_t hornerOperations = CountOperations(horner, false);
+    delete poly;
+    if (hornerOperations < operations) {
+        delete tree;
+        operations = hornerOperations;
+        return horner;
+    }
+    delete horner;
+    return tree;
+}
+
+/**
+ * Adds two coefficients, failing if the result leaves the int range
+ * that SimplifyTree works in
+ * @param sum receives a + b
+ * @return true if in range
+ */
+static bool AddCoefficient(long long a, long long b, long long& sum) {
+    sum = a + b;
+    return sum >= INT_MIN && sum <= INT_MAX;
+}
+
+/**
+ * Returns the polynomial for a leaf.  Only numbers and interned
+ * variables qualify; leaves such as "2x" that SimplifyTree builds by
+ * concatenating text are not reliable terms and are left alone.
+ * @param leaf a NumberOperand or VariableOperand node
+ * @return new polynomial, or nullptr
+ */
+ExpressionTree::Polynomial* ExpressionTree::LeafPolynomial(TreeNode* leaf) const {
+    const string& data = leaf->Data();
+    Polynomial* poly;
+
+    if (leaf->Type() == VariableOperand) {
+        if (leaf->Symbols() == nullptr) {
+            return nullptr;
+        }
+        poly = new Polynomial;
+        poly->variable = leaf;
+        poly->degree = 1;
+        poly->coefficient[0] = 0;
+        poly->coefficient[1] = 1;
+        return poly;
+    }
+
+    size_t digitsStart = data.length() > 0 && data[0] == '-' ? 1 : 0;
+    size_t digits = data.length() - digitsStart;
+    if (digits == 0 || digits > 9 || !IsNumber(data.substr(digitsStart))) {
+        return nullptr;
+    }
+    poly = new Polynomial;
+    poly->variable = nullptr;
+    poly->degree = 0;
+    poly->coefficient[0] = stoll(data);
+    return poly;
+}
+
+/**
+ * Combines the polynomials of two operands
+ * @param op the operator, +, - or *
+ * @param left polynomial of the left operand, may be nullptr
+ * @param right polynomial of the right operand, may be nullptr
+ * @return new polynomial, or nullptr if either operand is not a
+ * polynomial, they use different variables, or the result would be too
+ * high a degree or have coefficients out of range
+ */
+ExpressionTree::Polynomial* ExpressionTree::CombinePolynomials(const string& op, const Polynomial* left, const Polynomial* right) const {
+    if (left == nullptr || right == nullptr) {
+        return nullptr;
+    }
+    if (left->variable != nullptr && right->variable != nullptr && !left->variable->SameData(right->variable)) {
+        return nullptr;
+    }
+    int degree = op == "*" ? left->degree + right->degree : (left->degree > right->degree ? left->degree : right->degree);
+    if (degree > MaxPolynomialDegree) {
+        return nullptr;
+    }
+
+    Polynomial* poly = new Polynomial;
+    poly->variable = left->variable != nullptr ? left->variable : right->variable;
+    poly->degree = degree;
+    bool ok = true;
+    if (op == "*") {
+        for (int i = 0; i <= degree; i ++) {
+            poly->coefficient[i] = 0;
+        }
+        for (int i = 0; ok && i <= left->degree; i ++) {
+            for (int j = 0; ok && j <= right->degree; j ++) {
+                ok = AddCoefficient(poly->coefficient[i+j], left->coefficient[i] * right->coefficient[j], poly->coefficient[i+j]);
+            }
+        }
+    }
+    else {
+        long long sign = op == "-" ? -1 : 1;
+        for (int i = 0; ok && i <= degree; i ++) {
+            long long a = i <= left->degree ? left->coefficient[i] : 0;
+            long long b = i <= right->degree ? right->coefficient[i] : 0;
+            ok = AddCoefficient(a, sign * b, poly->coefficient[i]);
+        }
+    }
+    if (!ok) {
+        delete poly;
+        return nullptr;
+    }
+    while (poly->degree > 0 && poly->coefficient[poly->degree] == 0) {
+        poly->degree --;
+    }
+    return poly;
+}
+
+/**
+ * Builds variable * tree, writing a constant factor on the left and
+ * dropping a factor of 1
+ */
+static TreeNode* MakeProduct(const TreeNode* variable, TreeNode* tree) {
+    if (tree->IsOne()) {
+        delete tree;
+        return VariableLeaf(variable);
+    }
+    TreeNode* product = new TreeNode(Operator, "*");
+    if (tree->IsNumber()) {
+        product->SetLeft(tree);
+        product->SetRight(VariableLeaf(variable));
+    }
+    else {
+        product->SetLeft(VariableLeaf(variable));
+        product->SetRight(tree);
+    }
+    return product;
+}
+
+/**
+ * Builds constant + tree, or tree - |constant| for a negative constant
+ */
+static TreeNode* MakeSum(long long constant, TreeNode* tree) {
+    if (constant == 0) {
+        return tree;
+    }
+    TreeNode* sum;
+    if (constant > 0) {
+        sum = new TreeNode(Operator, "+");
+        sum->SetLeft(new TreeNode(NumberOperand, to_string(constant)));
+        sum->SetRight(tree);
+    }
+    else {
+        sum = new TreeNode(Operator, "-");
+        sum->SetLeft(tree);
+        sum->SetRight(new TreeNode(NumberOperand, to_string(-constant)));
+    }
+    return sum;
+}
+
+/**
+ * Builds the Horner form of a polynomial, factoring out the lowest power
+ * of the variable that appears: c0 + x*(c1 + x*(c2 + ...))
+ * @param poly the polynomial
+ * @return newly allocated tree
+ */
+TreeNode* ExpressionTree::BuildHorner(const Polynomial& poly) const {
+    int lowest = 0;
+    while (lowest < poly.degree && poly.coefficient[lowest] == 0) {
+        lowest ++;
+    }
+
+    TreeNode* tree = new TreeNode(NumberOperand, to_string(poly.coefficient[poly.degree]));
+    for (int i = poly.degree - 1; i >= lowest; i --) {
+        tree = MakeSum(poly.coefficient[i], MakeProduct(poly.variable, tree));
+    }
+    for (int i = 0; i < lowest; i ++) {
+        tree = MakeProduct(poly.variable, tree);
+    }
+    return tree;
+}
+
+/**
+ * Counts the operators in a tree.  A leaf produced by SimplifyTree such
+ * as "2x" stands for a multiplication and is counted as one.
+ * @param tree tree to count
+ * @param multipliesOnly count only multiplications if true
+ * @return number of operations needed to evaluate the tree
+ */
+size_t ExpressionTree::CountOperations(TreeNode* tree, bool multipliesOnly) const {
+    if (tree == nullptr) {
+        return 0;
+    }
+    if (tree->Type() != Operator) {
+        return tree->Type() == VariableOperand && !IsVariable(tree->Data()) ? 1 : 0;
+    }
+    size_t count = CountOperations(tree->Left(), multipliesOnly) + CountOperations(tree->Right(), multipliesOnly);
+    if (!multipliesOnly || tree->Data() == "*") {
+        count ++;
+    }
+    return count;
+}
+
 /**
  * Produce an infix representation of the tree structure
  * @param tree
@@ -6,6 +6,7 @@
 #ifndef EXPRESSIONTREE_H
 #define EXPRESSIONTREE_H
 
+#include "PostfixBuilder.h"
 #include "TreeNode.h"
 
 class ExpressionTree {
@@ -13,19 +14,47 @@ public:
     ExpressionTree();
     ~ExpressionTree();
 
+    ExpressionTree(const ExpressionTree&);
+    const ExpressionTree& operator=(const ExpressionTree&);
+
+    void SetLimits(const ParseLimits& limits) { _limits = limits; };
+    const ParseLimits& Limits() const { return _limits; };
+    void SetSymbolTable(SymbolTable* symbols) { _symbols = symbols; };
+
     bool BuildExpressionTree(const string& postfix);
+    bool BuildExpressionTree(PostfixBuilder& builder);
     void Simplify() { _root = SimplifyTree(_root); };
+    void Optimize();
+    size_t OperationCount() const { return CountOperations(_root, false); };
+    size_t MultiplyCount() const { return CountOperations(_root, true); };
 
     friend ostream& operator<<(ostream& os, const ExpressionTree& tree) {
         return os << tree.ToString(tree._root, false);
     }
 
 private:
+    // Polynomial in a single variable, used by the Horner rewrite
+    static const int MaxPolynomialDegree = 32;
+    struct Polynomial {
+        const TreeNode* variable;   // a leaf holding the variable, nullptr if constant
+        long long coefficient[MaxPolynomialDegree + 1];
+        int degree;
+    };
+
+    TreeNode* CopyTree(TreeNode* tree) const;
     TreeNode* SimplifyTree(TreeNode* tree);
+    TreeNode* OptimizeTree(TreeNode* tree, Polynomial*& poly, size_t& operations);
+    TreeNode* RewritePolynomial(TreeNode* tree, Polynomial* poly, size_t& operations);
+    Polynomial* LeafPolynomial(TreeNode* leaf) const;
+    Polynomial* CombinePolynomials(const string& op, const Polynomial* left, const Polynomial* right) const;
+    TreeNode* BuildHorner(const Polynomial& poly) const;
+    size_t CountOperations(TreeNode* tree, bool multipliesOnly) const;
     string ToString(TreeNode* tree, bool NeedOuterParen) const;
     bool IsSameTree(TreeNode* tree1, TreeNode* tree2) const;
 
     TreeNode* _root;
+    ParseLimits _limits;
+    SymbolTable* _symbols;
 };
 
 #endif //EXPRESSIONTREE_H
@@ -0,0 +1,104 @@
+//
+// Implements the MemoryScope Class and the counting operator new/delete
+//
+
+#include "MemoryAccounting.h"
+
+#ifdef EXPRESSION_MEMORY_ACCOUNTING
+
+#include <cstdlib>
+#include <new>
+
+// Every block carries its size in a header so delete can credit it back;
+// the header keeps the user pointer at the platform's maximum alignment
+static const size_t HeaderSize = alignof(std::max_align_t);
+
+static thread_local MemoryCounter* currentCounter = nullptr;
+
+/**
+ * Constructor
+ * Makes counter current for the calling thread
+ * @param counter receives the allocations made while this scope is alive,
+ * or nullptr to count nothing
+ */
+MemoryScope::MemoryScope(MemoryCounter* counter) {
+    _previous = currentCounter;
+    currentCounter = counter;
+}
+
+/**
+ * Destructor
+ * Restores the counter that was current before this scope
+ */
+MemoryScope::~MemoryScope() {
+    currentCounter = _previous;
+}
+
+/**
+ * Allocates a block with a size header and charges the current counter
+ * @param size bytes requested
+ * @return user pointer, or nullptr if out of memory
+ */
+static void* CountedAllocate(size_t size) {
+    char* block = static_cast<char*>(malloc(size + HeaderSize));
+    if (block == nullptr) {
+        return nullptr;
+    }
+    *reinterpret_cast<size_t*>(block) = size;
+    if (currentCounter != nullptr) {
+        currentCounter->Allocated(size);
+    }
+    return block + HeaderSize;
+}
+
+/**
+ * Frees a block from CountedAllocate and credits the current counter
+ * @param pointer user pointer, may be nullptr
+ */
+static void CountedFree(void* pointer) {
+    if (pointer == nullptr) {
+        return;
+    }
+    char* block = static_cast<char*>(pointer) - HeaderSize;
+    if (currentCounter != nullptr) {
+        currentCounter->Freed(*reinterpret_cast<size_t*>(block));
+    }
+    free(block);
+}
+
+/**
+ * Allocates like the standard operator new, calling the new handler
+ * until the allocation succeeds or no handler is installed
+ */
+static void* CountedNew(size_t size) {
+    for (;;) {
+        void* pointer = CountedAllocate(size == 0 ? 1 : size);
+        if (pointer != nullptr) {
+            return pointer;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void* operator new(size_t size) { return CountedNew(size); }
+void* operator new[](size_t size) { return CountedNew(size); }
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    try { return CountedNew(size); } catch (...) { return nullptr; }
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    try { return CountedNew(size); } catch (...) { return nullptr; }
+}
+
+void operator delete(void* pointer) noexcept { CountedFree(pointer); }
+void operator delete[](void* pointer) noexcept { CountedFree(pointer); }
+void operator delete(void* pointer, size_t) noexcept { CountedFree(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { CountedFree(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { CountedFree(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { CountedFree(pointer); }
+
+#endif //EXPRESSION_MEMORY_ACCOUNTING
@@ -0,0 +1,77 @@
+//
+// Interface Definition for the MemoryCounter and MemoryScope Classes
+// When built with EXPRESSION_MEMORY_ACCOUNTING the global operator new and
+// delete are replaced by versions that charge every allocation made on a
+// thread to the MemoryCounter of its innermost active MemoryScope.  Without
+// the flag these classes compile to nothing and new/delete are untouched.
+//
+
+#ifndef MEMORYACCOUNTING_H
+#define MEMORYACCOUNTING_H
+
+#include <cstddef>
+#include <cstdint>
+
+//
+// Byte and allocation counts for one expression or phase.  Counts are
+// also charged to the parent, so a phase counter can roll up into an
+// expression counter.  Memory freed while a counter is active is taken
+// off that counter even if another phase allocated it, so liveBytes of a
+// phase is its net growth and may be negative.
+//
+struct MemoryCounter {
+    explicit MemoryCounter(MemoryCounter* parentCounter = nullptr) : parent(parentCounter) {};
+
+    void Allocated(size_t bytes) {
+        for (MemoryCounter* counter = this; counter != nullptr; counter = counter->parent) {
+            counter->allocations ++;
+            counter->liveBytes += bytes;
+            if (counter->liveBytes > counter->peakBytes) {
+                counter->peakBytes = counter->liveBytes;
+            }
+        }
+    };
+    void Freed(size_t bytes) {
+        for (MemoryCounter* counter = this; counter != nullptr; counter = counter->parent) {
+            counter->liveBytes -= bytes;
+        }
+    };
+
+    MemoryCounter* parent;
+    int64_t liveBytes = 0;
+    int64_t peakBytes = 0;
+    uint64_t allocations = 0;
+};
+
+#ifdef EXPRESSION_MEMORY_ACCOUNTING
+
+//
+// Makes a counter the current one for this thread until destroyed.
+// A null counter turns counting off for the scope.
+//
+class MemoryScope {
+public:
+    explicit MemoryScope(MemoryCounter* counter);
+    ~MemoryScope();
+
+    MemoryScope(const MemoryScope&) = delete;
+    const MemoryScope& operator=(const MemoryScope&) = delete;
+
+private:
+    MemoryCounter* _previous;
+};
+
+inline bool MemoryAccountingEnabled() { return true; }
+
+#else
+
+class MemoryScope {
+public:
+    explicit MemoryScope(MemoryCounter*) {};
+};
+
+inline bool MemoryAccountingEnabled() { return false; }
+
+#endif //EXPRESSION_MEMORY_ACCOUNTING
+
+#endif //MEMORYACCOUNTING_H
@@ -0,0 +1,214 @@
+//
+// Implements the PostfixBuilder Class
+//
+
+#include <climits>
+#include "PostfixBuilder.h"
+#include "Tokens.h"
+using std::to_string;
+
+/**
+ * Constructor
+ * @param limits resource limits checked as the input arrives
+ * @param symbols table variable names are interned in
+ */
+PostfixBuilder::PostfixBuilder(const ParseLimits& limits, SymbolTable* symbols) {
+    _limits = limits;
+    _symbols = symbols;
+    Reset();
+}
+
+/**
+ * Destructor
+ * Frees any partially built subtrees
+ */
+PostfixBuilder::~PostfixBuilder() {
+    _operands.Clear([](TreeNode* node) { delete node; });
+}
+
+/**
+ * Discards any partial state and starts a new expression.  The time
+ * budget counts only time spent inside Feed and Finish, so waiting for
+ * input, before or in the middle of a line, does not count against it.
+ */
+void PostfixBuilder::Reset() {
+    _operands.Clear([](TreeNode* node) { delete node; });
+    _depths.Clear();
+    _token.clear();
+    _error.clear();
+    _nodeCount = 0;
+    _tokenCount = 0;
+    _finished = false;
+    _elapsed = std::chrono::steady_clock::duration::zero();
+}
+
+/**
+ * Consumes the next chunk of postfix text.  A token may be split across
+ * calls.  Limits are checked as tokens complete; the token length limit
+ * is checked before an oversized token is buffered.
+ * @param data chunk of text, need not be null terminated
+ * @param length number of characters in data
+ * @return false if the input is invalid so far, true otherwise
+ */
+bool PostfixBuilder::Feed(const char* data, size_t length) {
+    if (Failed() || _finished) {
+        return false;
+    }
+    _callStart = std::chrono::steady_clock::now();
+    bool valid = Scan(data, length);
+    _elapsed += std::chrono::steady_clock::now() - _callStart;
+    return valid;
+}
+
+/**
+ * Splits a chunk into tokens for Feed
+ * @param data chunk of text
+ * @param length number of characters in data
+ * @return false if the input is invalid so far, true otherwise
+ */
+bool PostfixBuilder::Scan(const char* data, size_t length) {
+    size_t position = 0;
+    while (position < length) {
+        if (isspace((unsigned char) data[position])) {
+            if (!_token.empty() && !AcceptToken()) {
+                return false;
+            }
+            position ++;
+            continue;
+        }
+
+        size_t start = position;
+        size_t room = _limits.maxTokenLength == 0 ? length : _limits.maxTokenLength - _token.length();
+        while (position < length && !isspace((unsigned char) data[position]) && position - start <= room) {
+            position ++;
+        }
+        if (position - start > room) {
+            return Fail("token " + to_string(_tokenCount+1) + " exceeds " + to_string(_limits.maxTokenLength) + " characters");
+        }
+        _token.append(data + start, position - start);
+    }
+    return true;
+}
+
+/**
+ * Ends the expression, accepting any token still pending
+ * @return true if the input formed exactly one expression
+ */
+bool PostfixBuilder::Finish() {
+    if (Failed() || _finished) {
+        return !Failed() && _finished;
+    }
+    _callStart = std::chrono::steady_clock::now();
+    bool valid = _token.empty() || AcceptToken();
+    _elapsed += std::chrono::steady_clock::now() - _callStart;
+    if (!valid) {
+        return false;
+    }
+    if (_operands.Size() != 1) {
+        return Fail("postfix expression is not valid");
+    }
+    _finished = true;
+    return true;
+}
+
+/**
+ * Hands the finished tree to the caller
+ * @return root of the tree, or nullptr if Finish did not succeed
+ */
+TreeNode* PostfixBuilder::Release() {
+    if (!_finished || _operands.IsEmpty()) {
+        return nullptr;
+    }
+    _depths.Clear();
+    return _operands.Pop();
+}
+
+/**
+ * Records an error and frees the partial tree in one pass
+ * @param error message describing the problem
+ * @return false, for use in return statements
+ */
+bool PostfixBuilder::Fail(const string& error) {
+    _error = error;
+    _operands.Clear([](TreeNode* node) { delete node; });
+    _depths.Clear();
+    _token.clear();
+    return false;
+}
+
+/**
+ * Checks that a string of digits is no larger than INT_MAX, the largest
+ * value SimplifyTree can convert
+ * @param token a number token
+ * @return true if the value fits in an int
+ */
+bool PostfixBuilder::FitsInInt(const string& token) {
+    long long value = 0;
+    for (size_t i = 0; i < token.length(); i ++) {
+        value = 10 * value + (token[i] - '0');
+        if (value > INT_MAX) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Pushes an operand or reduces an operator for the token in _token
+ * @return false if the token is invalid or breaks a limit
+ */
+bool PostfixBuilder::AcceptToken() {
+    string token;
+    token.swap(_token);
+    _tokenCount ++;
+
+    if (_limits.maxMilliseconds != 0 && _tokenCount % 256 == 0 &&
+        _elapsed + (std::chrono::steady_clock::now() - _callStart) > std::chrono::milliseconds(_limits.maxMilliseconds)) {
+        return Fail("time budget of " + to_string(_limits.maxMilliseconds) + " ms exceeded at token " + to_string(_tokenCount));
+    }
+    if (_limits.maxNodes != 0 && _nodeCount >= _limits.maxNodes) {
+        return Fail("expression exceeds " + to_string(_limits.maxNodes) + " nodes at token " + to_string(_tokenCount));
+    }
+
+    if (IsNumber(token)) {
+        if (_limits.maxNumberDigits != 0 && token.length() > _limits.maxNumberDigits) {
+            return Fail("number at token " + to_string(_tokenCount) + " exceeds " + to_string(_limits.maxNumberDigits) + " digits");
+        }
+        if (!FitsInInt(token)) {
+            return Fail("number at token " + to_string(_tokenCount) + " exceeds " + to_string(INT_MAX));
+        }
+        _operands.Push(new TreeNode(NumberOperand, token));
+        _depths.Push(1);
+        _nodeCount ++;
+    }
+    else if (IsVariable(token)) {
+        SymbolId symbol = _symbols->Intern(token);
+        if (symbol == NoSymbol) {
+            return Fail("symbol table full at token " + to_string(_tokenCount));
+        }
+        _operands.Push(new TreeNode(_symbols, symbol));
+        _depths.Push(1);
+        _nodeCount ++;
+    }
+    else if (IsOperator(token)) {
+        if (_operands.Size() < 2) {
+            return Fail("operator found with no operands");
+        }
+        size_t rightDepth = _depths.Pop();
+        size_t leftDepth = _depths.Pop();
+        size_t depth = 1 + (leftDepth > rightDepth ? leftDepth : rightDepth);
+        if (_limits.maxDepth != 0 && depth > _limits.maxDepth) {
+            return Fail("expression exceeds depth " + to_string(_limits.maxDepth) + " at token " + to_string(_tokenCount));
+        }
+        TreeNode* expression = new TreeNode(Operator, token);
+        expression->SetRight(_operands.Pop());
+        expression->SetLeft(_operands.Pop());
+        _operands.Push(expression);
+        _depths.Push(depth);
+        _nodeCount ++;
+    }
+    else {
+        return Fail("input " + token + " not valid");
+    }
+    return true;
+}
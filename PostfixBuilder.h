@@ -0,0 +1,64 @@
+//
+// Interface Definition for the PostfixBuilder Class
+// Push-style construction of an expression tree: postfix text is handed
+// over in chunks of any size with Feed, and tokens split across chunk
+// boundaries are carried over, so the whole expression never has to be
+// held in memory.
+//
+
+#ifndef POSTFIXBUILDER_H
+#define POSTFIXBUILDER_H
+
+#include <chrono>
+#include "Stack.h"
+#include "TreeNode.h"
+
+//
+// Resource limits enforced while a postfix expression is being built.
+// A value of 0 disables that particular limit.
+//
+struct ParseLimits {
+    size_t maxNodes = 1000000;      // tree nodes created for one expression
+    size_t maxDepth = 10000;        // height of the tree (recursion depth of later passes)
+    size_t maxNumberDigits = 0;     // digits in a number literal; values above INT_MAX are always rejected
+    size_t maxTokenLength = 256;    // characters in any single token
+    long maxMilliseconds = 0;       // time spent in Feed and Finish for one expression
+};
+
+class PostfixBuilder {
+public:
+    explicit PostfixBuilder(const ParseLimits& limits = ParseLimits(),
+                            SymbolTable* symbols = &SymbolTable::Global());
+    ~PostfixBuilder();
+
+    PostfixBuilder(const PostfixBuilder&) = delete;
+    const PostfixBuilder& operator=(const PostfixBuilder&) = delete;
+
+    bool Feed(const char* data, size_t length);
+    bool Finish();
+    TreeNode* Release();
+    void Reset();
+
+    bool Failed() const { return !_error.empty(); };
+    const string& Error() const { return _error; };
+
+private:
+    static bool FitsInInt(const string& token);
+    bool Scan(const char* data, size_t length);
+    bool AcceptToken();
+    bool Fail(const string& error);
+
+    ParseLimits _limits;
+    SymbolTable* _symbols;
+    Stack<TreeNode*> _operands;
+    Stack<size_t> _depths;
+    string _token;
+    string _error;
+    size_t _nodeCount;
+    size_t _tokenCount;
+    bool _finished;
+    std::chrono::steady_clock::duration _elapsed;       // time spent in earlier Feed and Finish calls
+    std::chrono::steady_clock::time_point _callStart;   // start of the current call
+};
+
+#endif //POSTFIXBUILDER_H
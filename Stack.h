@@ -18,6 +18,8 @@ public:
     bool Push(const ValueType& value);
     ValueType Peek();
     ValueType Pop();
+    void Clear();
+    template <typename Disposer> void Clear(Disposer dispose);
 
     friend ostream& operator<<(ostream& os, const Stack& stack) {
         return os << stack._list;
@@ -85,4 +87,32 @@ ValueType Stack<ValueType>::Peek() {
     return value;
 }
 
+/**
+* Removes all values from the stack at once
+* Unlike repeated Pop calls, the underlying list is not shrunk
+* one step at a time.
+*/
+template <typename ValueType>
+void Stack<ValueType>::Clear() {
+    _list.Clear();
+}
+
+/**
+* Removes all values from the stack at once, handing each one to
+* "dispose" first.  Used to free owned pointers left on the stack.
+* @param dispose callable invoked with each value, top of stack first
+*/
+template <typename ValueType>
+template <typename Disposer>
+void Stack<ValueType>::Clear(Disposer dispose) {
+    ValueType value;
+
+    for (size_t i = _list.Size(); i > 0; i --) {
+        if (_list.Get(i-1, value)) {
+            dispose(value);
+        }
+    }
+    _list.Clear();
+}
+
 #endif //STACK_H
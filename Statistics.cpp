@@ -0,0 +1,248 @@
+//
+// Implements the LatencyHistogram and DriverStatistics Classes
+//
+
+#include <iomanip>
+#include "Statistics.h"
+using std::endl;
+using std::setw;
+
+/**
+ * Default constructor
+ * Creates an empty histogram
+ */
+LatencyHistogram::LatencyHistogram() {
+    for (int i = 0; i < BucketCount; i ++) {
+        _counts[i] = 0;
+    }
+    _count = 0;
+    _sum = 0;
+    _min = UINT64_MAX;
+    _max = 0;
+}
+
+/**
+ * Position of the highest set bit
+ * @param value a nonzero value
+ * @return bit number, 0 for the least significant bit
+ */
+static int HighestBit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(value);
+#else
+    int bit = 0;
+    for (int shift = 32; shift > 0; shift /= 2) {
+        if (value >> shift) {
+            value >>= shift;
+            bit += shift;
+        }
+    }
+    return bit;
+#endif
+}
+
+/**
+ * Maps a value to its bucket.  Values below 64 get a bucket each, above
+ * that the top six significant bits select the bucket.
+ * @param value value to be recorded
+ * @return index into _counts
+ */
+int LatencyHistogram::BucketIndex(uint64_t value) {
+    if (value < 2 * SubBucketCount) {
+        return (int) value;
+    }
+    int msb = HighestBit(value);
+    int shift = msb - SubBucketBits;
+    return (shift + 1) * SubBucketCount + (int) ((value >> shift) - SubBucketCount);
+}
+
+/**
+ * Inverse of BucketIndex
+ * @param index bucket index
+ * @return largest value that falls into the bucket
+ */
+uint64_t LatencyHistogram::BucketHighestValue(int index) {
+    if (index < 2 * SubBucketCount) {
+        return index;
+    }
+    int shift = index / SubBucketCount - 1;
+    uint64_t top = index % SubBucketCount + SubBucketCount;
+    return ((top + 1) << shift) - 1;
+}
+
+/**
+ * Records one value
+ * @param value latency in nanoseconds
+ */
+void LatencyHistogram::Record(uint64_t value) {
+    _counts[BucketIndex(value)] ++;
+    _count ++;
+    _sum += value;
+    if (value < _min) { _min = value; }
+    if (value > _max) { _max = value; }
+}
+
+/**
+ * Returns the value at a given percentile
+ * @param percentile between 0 and 100
+ * @return upper bound of the bucket holding that percentile, never more than Max()
+ */
+uint64_t LatencyHistogram::Percentile(double percentile) const {
+    if (_count == 0) {
+        return 0;
+    }
+    uint64_t target = (uint64_t) (percentile / 100.0 * _count + 0.5);
+    if (target < 1) { target = 1; }
+    if (target > _count) { target = _count; }
+
+    uint64_t seen = 0;
+    for (int i = 0; i < BucketCount; i ++) {
+        seen += _counts[i];
+        if (seen >= target) {
+            uint64_t value = BucketHighestValue(i);
+            return value < _max ? value : _max;
+        }
+    }
+    return _max;
+}
+
+/**
+ * Writes the histogram summary as a JSON object
+ * @param os stream to write to
+ */
+void LatencyHistogram::WriteJson(ostream& os) const {
+    os << "{\"count\":" << _count
+       << ",\"mean\":" << (uint64_t) Mean()
+       << ",\"p50\":" << Percentile(50)
+       << ",\"p99\":" << Percentile(99)
+       << ",\"p999\":" << Percentile(99.9)
+       << ",\"max\":" << _max << "}";
+}
+
+/**
+ * Default constructor
+ * Creates empty statistics
+ */
+DriverStatistics::DriverStatistics() {
+    _expressions = 0;
+    _errors = 0;
+    _bytesIn = 0;
+    _bytesOut = 0;
+    _slowestSize = 0;
+}
+
+/**
+ * Records an input line that failed to parse
+ * @param line input line number
+ * @param parseNanos time spent before the error was detected
+ * @param bytesIn bytes of input
+ */
+void DriverStatistics::RecordError(size_t line, uint64_t parseNanos, uint64_t bytesIn) {
+    _errors ++;
+    _bytesIn += bytesIn;
+    _parse.Record(parseNanos);
+    _total.Record(parseNanos);
+    TrackSlowest(line, parseNanos);
+}
+
+/**
+ * Records an expression that was parsed, simplified and printed
+ * @param line input line number
+ * @param parseNanos time to build the tree
+ * @param simplifyNanos time to simplify the tree
+ * @param printNanos time to produce the infix strings
+ * @param bytesIn bytes of input
+ * @param bytesOut bytes of output
+ */
+void DriverStatistics::RecordExpression(size_t line, uint64_t parseNanos, uint64_t simplifyNanos, uint64_t printNanos,
+                                        uint64_t bytesIn, uint64_t bytesOut) {
+    _expressions ++;
+    _bytesIn += bytesIn;
+    _bytesOut += bytesOut;
+    _parse.Record(parseNanos);
+    _simplify.Record(simplifyNanos);
+    _print.Record(printNanos);
+    _total.Record(parseNanos + simplifyNanos + printNanos);
+    TrackSlowest(line, parseNanos + simplifyNanos + printNanos);
+}
+
+/**
+ * Keeps the lines with the largest total time, slowest first
+ * @param line input line number
+ * @param totalNanos time spent on the line
+ */
+void DriverStatistics::TrackSlowest(size_t line, uint64_t totalNanos) {
+    int position = _slowestSize;
+    while (position > 0 && _slowestNanos[position-1] < totalNanos) {
+        position --;
+    }
+    if (position == SlowestCount) {
+        return;
+    }
+    int last = _slowestSize < SlowestCount ? _slowestSize : SlowestCount - 1;
+    for (int i = last; i > position; i --) {
+        _slowestLines[i] = _slowestLines[i-1];
+        _slowestNanos[i] = _slowestNanos[i-1];
+    }
+    _slowestLines[position] = line;
+    _slowestNanos[position] = totalNanos;
+    if (_slowestSize < SlowestCount) {
+        _slowestSize ++;
+    }
+}
+
+/**
+ * Writes a human readable summary
+ * @param os stream to write to
+ * @param elapsedSeconds wall-clock time of the run
+ */
+void DriverStatistics::WriteSummary(ostream& os, double elapsedSeconds) const {
+    const char* names[] = { "parse", "simplify", "print", "total" };
+    const LatencyHistogram* histograms[] = { &_parse, &_simplify, &_print, &_total };
+
+    os << "Expressions: " << _expressions << "  Errors: " << _errors
+       << "  Bytes in: " << _bytesIn << "  Bytes out: " << _bytesOut << endl;
+    if (elapsedSeconds > 0) {
+        os << "Throughput: " << (uint64_t) ((_expressions + _errors) / elapsedSeconds) << " lines/s, "
+           << (uint64_t) (_bytesIn / elapsedSeconds) << " bytes/s in" << endl;
+    }
+    os << "Latency (ns)      p50       p99      p999       max" << endl;
+    for (int i = 0; i < 4; i ++) {
+        os << setw(10) << names[i]
+           << setw(9) << histograms[i]->Percentile(50)
+           << setw(10) << histograms[i]->Percentile(99)
+           << setw(10) << histograms[i]->Percentile(99.9)
+           << setw(10) << histograms[i]->Max() << endl;
+    }
+    os << "Slowest lines:";
+    for (int i = 0; i < _slowestSize; i ++) {
+        os << " " << _slowestLines[i] << " (" << _slowestNanos[i] << " ns)";
+    }
+    os << endl;
+}
+
+/**
+ * Writes a snapshot of the statistics as a single JSON line
+ * @param os stream to write to
+ * @param elapsedSeconds wall-clock time so far
+ */
+void DriverStatistics::WriteJsonLine(ostream& os, double elapsedSeconds) const {
+    os << "{\"elapsed_s\":" << elapsedSeconds
+       << ",\"expressions\":" << _expressions
+       << ",\"errors\":" << _errors
+       << ",\"bytes_in\":" << _bytesIn
+       << ",\"bytes_out\":" << _bytesOut
+       << ",\"parse_ns\":";
+    _parse.WriteJson(os);
+    os << ",\"simplify_ns\":";
+    _simplify.WriteJson(os);
+    os << ",\"print_ns\":";
+    _print.WriteJson(os);
+    os << ",\"total_ns\":";
+    _total.WriteJson(os);
+    os << ",\"slowest_lines\":[";
+    for (int i = 0; i < _slowestSize; i ++) {
+        os << (i > 0 ? "," : "") << "{\"line\":" << _slowestLines[i] << ",\"ns\":" << _slowestNanos[i] << "}";
+    }
+    os << "]}" << endl;
+}
@@ -0,0 +1,81 @@
+//
+// Interface Definition for the LatencyHistogram and DriverStatistics Classes
+//
+
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include <cstdint>
+#include <iostream>
+using std::ostream;
+
+//
+// Log-linear (HDR style) histogram of nanosecond latencies.  Every power
+// of two range is split into 32 equal sub-buckets, so recorded values
+// are kept to within about 3% using a fixed 15KB table and O(1) Record.
+//
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void Record(uint64_t value);
+    uint64_t Percentile(double percentile) const;
+
+    uint64_t Count() const { return _count; };
+    uint64_t Min() const { return _count == 0 ? 0 : _min; };
+    uint64_t Max() const { return _max; };
+    double Mean() const { return _count == 0 ? 0.0 : (double) _sum / _count; };
+
+    void WriteJson(ostream& os) const;
+
+private:
+    static const int SubBucketBits = 5;
+    static const int SubBucketCount = 1 << SubBucketBits;
+    static const int BucketCount = (64 - SubBucketBits + 1) * SubBucketCount;
+
+    static int BucketIndex(uint64_t value);
+    static uint64_t BucketHighestValue(int index);
+
+    uint64_t _counts[BucketCount];
+    uint64_t _count;
+    uint64_t _sum;
+    uint64_t _min;
+    uint64_t _max;
+};
+
+//
+// Per-phase timing, throughput and slowest-line tracking for the driver
+//
+class DriverStatistics {
+public:
+    DriverStatistics();
+
+    void RecordError(size_t line, uint64_t parseNanos, uint64_t bytesIn);
+    void RecordExpression(size_t line, uint64_t parseNanos, uint64_t simplifyNanos, uint64_t printNanos,
+                          uint64_t bytesIn, uint64_t bytesOut);
+
+    uint64_t Expressions() const { return _expressions; };
+    uint64_t Errors() const { return _errors; };
+
+    void WriteSummary(ostream& os, double elapsedSeconds) const;
+    void WriteJsonLine(ostream& os, double elapsedSeconds) const;
+
+private:
+    static const int SlowestCount = 5;
+
+    void TrackSlowest(size_t line, uint64_t totalNanos);
+
+    LatencyHistogram _parse;
+    LatencyHistogram _simplify;
+    LatencyHistogram _print;
+    LatencyHistogram _total;
+    uint64_t _expressions;
+    uint64_t _errors;
+    uint64_t _bytesIn;
+    uint64_t _bytesOut;
+    size_t _slowestLines[SlowestCount];
+    uint64_t _slowestNanos[SlowestCount];
+    int _slowestSize;
+};
+
+#endif //STATISTICS_H
@@ -0,0 +1,178 @@
+//
+// Implements the SymbolTable Class
+//
+
+#include <assert.h>
+#include <functional>
+#include "MemoryAccounting.h"
+#include "SymbolTable.h"
+using std::endl;
+
+/**
+ * Default constructor
+ * Creates an empty table
+ */
+SymbolTable::SymbolTable() : _size(0) {
+    for (size_t i = 0; i < MaxChunks; i ++) {
+        _chunks[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Destructor
+ * Frees the entry chunks
+ */
+SymbolTable::~SymbolTable() {
+    for (size_t i = 0; i < MaxChunks; i ++) {
+        delete[] _chunks[i].load(std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Returns the process-wide table used by default
+ * @return the global table
+ */
+SymbolTable& SymbolTable::Global() {
+    static SymbolTable table;
+    return table;
+}
+
+/**
+ * Returns the id for a name, adding it if it has not been seen, and
+ * counts one occurrence of it.  An existing name only takes a shared lock
+ * on one shard; new names take that shard's exclusive lock.
+ * @param name variable name
+ * @return the name's id
+ */
+SymbolId SymbolTable::Intern(const string& name) {
+    Shard& shard = _shards[std::hash<string>()(name) % ShardCount];
+    SymbolId id = NoSymbol;
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(shard.mutex);
+        auto found = shard.ids.find(name);
+        if (found != shard.ids.end()) {
+            id = found->second;
+        }
+    }
+    if (id == NoSymbol) {
+        std::unique_lock<std::shared_timed_mutex> lock(shard.mutex);
+        auto found = shard.ids.find(name);
+        if (found != shard.ids.end()) {
+            id = found->second;
+        }
+        else {
+            // The table outlives any one expression, so its storage is
+            // not charged to the caller's MemoryScope
+            MemoryScope scope(nullptr);
+            id = Allocate(name);
+            if (id == NoSymbol) {
+                return NoSymbol;
+            }
+            shard.ids.emplace(name, id);
+        }
+    }
+    EntryFor(id).occurrences.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+/**
+ * Removes every symbol so the table can be reused for the next expression
+ * or batch.  The first chunk of entries is kept for reuse.  The caller
+ * must make sure no other thread is using the table and no node still
+ * refers to one of its ids.
+ */
+void SymbolTable::Clear() {
+    MemoryScope scope(nullptr);
+    for (int i = 0; i < ShardCount; i ++) {
+        std::unique_lock<std::shared_timed_mutex> lock(_shards[i].mutex);
+        std::unordered_map<string, SymbolId>().swap(_shards[i].ids);
+    }
+    std::lock_guard<std::mutex> lock(_allocateMutex);
+    size_t size = _size.load(std::memory_order_relaxed);
+    Entry* first = _chunks[0].load(std::memory_order_relaxed);
+    for (size_t id = 0; id < size && id < ChunkSize; id ++) {
+        string().swap(first[id].name);
+        first[id].occurrences.store(0, std::memory_order_relaxed);
+    }
+    size_t chunks = (size + ChunkSize - 1) >> ChunkBits;
+    for (size_t i = 1; i < chunks; i ++) {
+        delete[] _chunks[i].exchange(nullptr, std::memory_order_relaxed);
+    }
+    _size.store(0, std::memory_order_release);
+}
+
+/**
+ * Looks up a name without adding it or counting an occurrence
+ * @param name variable name
+ * @return the name's id, or NoSymbol if it has not been interned
+ */
+SymbolId SymbolTable::Find(const string& name) const {
+    const Shard& shard = _shards[std::hash<string>()(name) % ShardCount];
+    std::shared_lock<std::shared_timed_mutex> lock(shard.mutex);
+    auto found = shard.ids.find(name);
+    return found == shard.ids.end() ? NoSymbol : found->second;
+}
+
+/**
+ * Returns the name for an id
+ * Caller should make sure id was returned by this table.
+ * @param id symbol id
+ * @return the interned name
+ */
+const string& SymbolTable::Name(SymbolId id) const {
+    return EntryFor(id).name;
+}
+
+/**
+ * Returns how many times a name has been interned
+ * @param id symbol id
+ * @return occurrence count
+ */
+uint64_t SymbolTable::Occurrences(SymbolId id) const {
+    return EntryFor(id).occurrences.load(std::memory_order_relaxed);
+}
+
+/**
+ * Writes one line per symbol: id, occurrences and name
+ * @param os stream to write to
+ */
+void SymbolTable::WriteStatistics(ostream& os) const {
+    size_t size = Size();
+    os << "Symbols: " << size << endl;
+    for (SymbolId id = 0; id < size; id ++) {
+        os << "  " << id << "\t" << Occurrences(id) << "\t" << Name(id) << endl;
+    }
+}
+
+/**
+ * Locates the entry for an id.  Chunks are never moved, and only Clear
+ * frees them, so this needs no lock.
+ */
+SymbolTable::Entry& SymbolTable::EntryFor(SymbolId id) const {
+    Entry* chunk = _chunks[id >> ChunkBits].load(std::memory_order_acquire);
+    assert(chunk != nullptr);
+    return chunk[id & (ChunkSize - 1)];
+}
+
+/**
+ * Assigns the next id to a name, adding a chunk of entries when needed.
+ * The entry is filled in before the id is published.
+ * @param name variable name
+ * @return new id, or NoSymbol if the table is full
+ */
+SymbolId SymbolTable::Allocate(const string& name) {
+    std::lock_guard<std::mutex> lock(_allocateMutex);
+    size_t id = _size.load(std::memory_order_relaxed);
+    if (id >= MaxChunks * ChunkSize) {
+        return NoSymbol;
+    }
+
+    Entry* chunk = _chunks[id >> ChunkBits].load(std::memory_order_relaxed);
+    if (chunk == nullptr) {
+        chunk = new Entry[ChunkSize];
+        _chunks[id >> ChunkBits].store(chunk, std::memory_order_release);
+    }
+    chunk[id & (ChunkSize - 1)].name = name;
+    _size.store(id + 1, std::memory_order_release);
+    return (SymbolId) id;
+}
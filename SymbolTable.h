@@ -0,0 +1,70 @@
+//
+// Interface Definition for the SymbolTable Class
+// Interns variable names as dense 32-bit ids so that nodes can compare and
+// hash variables as integers.  Lookups are sharded by name hash, and id to
+// name / statistics reads are lock-free, so parallel workers can share one
+// table.  Nothing is removed until Clear, so a long-running caller should
+// clear its table between expressions or batches.
+//
+
+#ifndef SYMBOLTABLE_H
+#define SYMBOLTABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+using std::ostream;
+using std::string;
+
+typedef uint32_t SymbolId;
+const SymbolId NoSymbol = UINT32_MAX;
+
+class SymbolTable {
+public:
+    SymbolTable();
+    ~SymbolTable();
+
+    SymbolTable(const SymbolTable&) = delete;
+    const SymbolTable& operator=(const SymbolTable&) = delete;
+
+    static SymbolTable& Global();
+
+    SymbolId Intern(const string& name);
+    void Clear();
+    SymbolId Find(const string& name) const;
+    const string& Name(SymbolId id) const;
+    uint64_t Occurrences(SymbolId id) const;
+    size_t Size() const { return _size.load(std::memory_order_acquire); };
+
+    void WriteStatistics(ostream& os) const;
+
+private:
+    static const int ShardCount = 16;
+    static const int ChunkBits = 10;
+    static const size_t ChunkSize = size_t(1) << ChunkBits;
+    static const size_t MaxChunks = 4096;
+
+    struct Entry {
+        string name;
+        std::atomic<uint64_t> occurrences{0};
+    };
+
+    struct Shard {
+        mutable std::shared_timed_mutex mutex;
+        std::unordered_map<string, SymbolId> ids;
+    };
+
+    Entry& EntryFor(SymbolId id) const;
+    SymbolId Allocate(const string& name);
+
+    Shard _shards[ShardCount];
+    std::atomic<Entry*> _chunks[MaxChunks];
+    std::mutex _allocateMutex;
+    std::atomic<size_t> _size;
+};
+
+#endif //SYMBOLTABLE_H
@@ -0,0 +1,14 @@
+//
+// Token testing routines shared by ExpressionTree and PostfixBuilder
+//
+#ifndef TOKENS_H
+#define TOKENS_H
+
+#include <string>
+using std::string;
+
+bool IsNumber(string token);
+bool IsVariable(string token);
+bool IsOperator(string token);
+
+#endif //TOKENS_H
@@ -15,6 +15,22 @@
 TreeNode::TreeNode(NodeType nodeType, string data) {
     _nodeType = nodeType;
     _data = data;
+    _symbols = nullptr;
+    _symbol = NoSymbol;
+    _left = nullptr;
+    _right = nullptr;
+}
+
+/**
+ * Constructor for an interned variable
+ * The node keeps only the id; Data() looks the name up in the table.
+ * @param symbols table the variable was interned in
+ * @param symbol id of the variable name
+ */
+TreeNode::TreeNode(const SymbolTable* symbols, SymbolId symbol) {
+    _nodeType = VariableOperand;
+    _symbols = symbols;
+    _symbol = symbol;
     _left = nullptr;
     _right = nullptr;
 }
@@ -39,3 +55,16 @@ bool TreeNode::SplitNumTimesVariable(int& c, TreeNode** ptree) const {
     assert(false);
     return false;
 }
+
+/**
+ * Compares the data of two nodes.  Variables interned in the same table
+ * are compared by id, anything else by its text.
+ * @param other node to compare with
+ * @return true if both nodes hold the same data
+ */
+bool TreeNode::SameData(const TreeNode* other) const {
+    if (_symbols != nullptr && _symbols == other->_symbols) {
+        return _symbol == other->_symbol;
+    }
+    return Data() == other->Data();
+}
@@ -7,6 +7,7 @@
 #define TREENODE_H
 
 #include <iostream>
+#include "SymbolTable.h"
 using std::ostream;
 using std::string;
 using std::to_string;
@@ -20,10 +21,13 @@ enum NodeType {
 class TreeNode {
 public:
     TreeNode(NodeType nodeType, string data);
+    TreeNode(const SymbolTable* symbols, SymbolId symbol);
     ~TreeNode();
 
     NodeType Type() const { return _nodeType; };
-    string Data() const {return _data;};
+    const string& Data() const {return _symbols == nullptr ? _data : _symbols->Name(_symbol);};
+    const SymbolTable* Symbols() const { return _symbols; };
+    SymbolId Symbol() const { return _symbol; };
     TreeNode *Left() const {return _left;};
     TreeNode *Right() const {return _right;};
 
@@ -34,10 +38,13 @@ public:
     bool IsZero() const { return _nodeType == NumberOperand && _data == "0"; };
     bool IsOne() const { return _nodeType == NumberOperand && _data == "1";};
     bool SplitNumTimesVariable(int& c, TreeNode** tree) const;
+    bool SameData(const TreeNode* other) const;
 
 private:
     NodeType _nodeType;
-    string _data;
+    string _data;                   // empty for interned variables
+    const SymbolTable* _symbols;    // table holding the name of an interned variable
+    SymbolId _symbol;
     TreeNode* _left;
     TreeNode* _right;
 };
@@ -1,32 +1,384 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <errno.h>
 #include <iostream>
+#include <sstream>
+#include <thread>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 using std::cin;
+using std::cerr;
 using std::cout;
 using std::endl;
 using std::string;
 using std::getline;
+using std::ostringstream;
+using Clock = std::chrono::steady_clock;
 
+#include "ChunkQueue.h"
 #include "ExpressionTree.h"
+#include "MemoryAccounting.h"
+#include "Statistics.h"
 
-int main() {
+//
+// Command line options and the statistics gathered across the run
+//
+struct Driver {
+    ParseLimits limits;
+    SymbolTable symbols;        // cleared before each expression
+    bool showStats = false;
+    bool optimize = false;
+    bool showSymbols = false;
+    bool trackMemory = false;
+    bool stream = false;
+    long statsInterval = 0;
+
+    DriverStatistics stats;
+    size_t lineNumber = 0;
+    int64_t maxPeakBytes = 0;
+    size_t maxPeakLine = 0;
+    Clock::time_point runStart;
+};
+
+/**
+ * Nanoseconds between two clock readings
+ */
+static uint64_t Nanos(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+}
+
+/**
+ * Seconds between two clock readings
+ */
+static double Seconds(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration<double>(end - start).count();
+}
+
+/**
+ * Parses a "--name=value" command line option holding a number
+ * @param arg the command line argument
+ * @param name option name including the leading dashes and trailing '='
+ * @param value receives the parsed number
+ * @return true if arg is this option and the value is a valid number
+ */
+static bool ParseOption(const char* arg, const char* name, long& value) {
+    size_t length = strlen(name);
+    if (strncmp(arg, name, length) != 0) {
+        return false;
+    }
+    char* end;
+    value = strtol(arg + length, &end, 10);
+    return *end == '\0' && end != arg + length && value >= 0;
+}
+
+/**
+ * Writes the counts for one phase as " name peak=P live=L allocs=A"
+ */
+static void WriteMemory(std::ostream& os, const char* name, const MemoryCounter& counter) {
+    os << " " << name << " peak=" << counter.peakBytes << " live=" << counter.liveBytes
+       << " allocs=" << counter.allocations;
+}
+
+/**
+ * Simplifies and prints an expression that has been parsed, then records
+ * its statistics.  Used by both the line and the streaming front ends.
+ * @param driver options and statistics
+ * @param expTree the parsed tree
+ * @param built whether parsing succeeded
+ * @param parseNanos time spent parsing
+ * @param bytesIn length of the postfix text
+ * @param expressionMemory counter for the whole expression
+ * @param parseMemory counter that was used while parsing
+ */
+static void ProcessExpression(Driver& driver, ExpressionTree& expTree, bool built, uint64_t parseNanos, size_t bytesIn,
+                              MemoryCounter& expressionMemory, MemoryCounter& parseMemory) {
+    MemoryCounter simplifyMemory(&expressionMemory);
+    MemoryCounter printMemory(&expressionMemory);
+
+    if (built) {
+        ostringstream infix;
+        ostringstream simplified;
+        ExpressionTree parsed;
+
+        // Optimize folds constants itself and cannot use the text leaves
+        // such as "2x" that Simplify produces, so it gets a copy of the
+        // parsed tree, made before any phase is timed
+        if (driver.optimize) {
+            parsed = expTree;
+        }
+
+        Clock::time_point infixStart = Clock::now();
+        {
+            MemoryScope scope(driver.trackMemory ? &printMemory : nullptr);
+            infix << expTree;
+        }
+        Clock::time_point infixEnd = Clock::now();
+        // Written before simplifying, so it still appears if that fails
+        cout << "Infix:  " << infix.str() << endl;
+
+        Clock::time_point simplifyStart = Clock::now();
+        {
+            MemoryScope scope(driver.trackMemory ? &simplifyMemory : nullptr);
+            expTree.Simplify();
+        }
+        Clock::time_point simplifyEnd = Clock::now();
+        {
+            MemoryScope scope(driver.trackMemory ? &printMemory : nullptr);
+            simplified << expTree;
+        }
+        Clock::time_point printEnd = Clock::now();
+        cout << "Simplified: " << simplified.str() << endl;
+        if (driver.optimize) {
+            size_t operations = parsed.OperationCount();
+            size_t multiplies = parsed.MultiplyCount();
+
+            parsed.Optimize();
+            cout << "Optimized: " << parsed << endl;
+            cout << "Operations: " << operations << " -> " << parsed.OperationCount()
+                 << " (multiplies " << multiplies << " -> " << parsed.MultiplyCount() << ")" << endl;
+        }
+        driver.stats.RecordExpression(driver.lineNumber, parseNanos, Nanos(simplifyStart, simplifyEnd),
+                                      Nanos(infixStart, infixEnd) + Nanos(simplifyEnd, printEnd),
+                                      bytesIn, infix.str().length() + simplified.str().length());
+    }
+    else {
+        driver.stats.RecordError(driver.lineNumber, parseNanos, bytesIn);
+    }
+    if (driver.showSymbols) {
+        cerr << "Line " << driver.lineNumber << ": ";
+        driver.symbols.WriteStatistics(cerr);
+    }
+    if (driver.trackMemory) {
+        cerr << "Memory: line " << driver.lineNumber;
+        WriteMemory(cerr, "parse", parseMemory);
+        if (built) {
+            WriteMemory(cerr, "simplify", simplifyMemory);
+            WriteMemory(cerr, "print", printMemory);
+        }
+        WriteMemory(cerr, "total", expressionMemory);
+        cerr << endl;
+        if (expressionMemory.peakBytes > driver.maxPeakBytes) {
+            driver.maxPeakBytes = expressionMemory.peakBytes;
+            driver.maxPeakLine = driver.lineNumber;
+        }
+    }
+    uint64_t processed = driver.stats.Expressions() + driver.stats.Errors();
+    if (driver.statsInterval > 0 && processed % driver.statsInterval == 0) {
+        driver.stats.WriteJsonLine(cerr, Seconds(driver.runStart, Clock::now()));
+    }
+}
+
+/**
+ * Reads standard input a line at a time, echoing each postfix expression
+ * @param driver options and statistics
+ */
+static void RunLines(Driver& driver) {
     string postfix;
 
     cout << "> ";
     while ( getline(cin, postfix) ) {
+        driver.lineNumber ++;
         if (postfix.length() == 0 || postfix[0] == '#') {
             cout << postfix << endl;
         }
         else {
             ExpressionTree expTree;
+            MemoryCounter expressionMemory;
+            MemoryCounter parseMemory(&expressionMemory);
+            bool built;
 
+            expTree.SetLimits(driver.limits);
+            expTree.SetSymbolTable(&driver.symbols);
+            driver.symbols.Clear();
             cout << "Postfix: " << postfix << endl;
-            if (expTree.BuildExpressionTree(postfix)) {
-                cout << "Infix:  " << expTree << endl;
-                expTree.Simplify();
-                cout << "Simplified: " << expTree << endl;
+
+            Clock::time_point parseStart = Clock::now();
+            {
+                MemoryScope scope(driver.trackMemory ? &parseMemory : nullptr);
+                built = expTree.BuildExpressionTree(postfix);
             }
+            ProcessExpression(driver, expTree, built, Nanos(parseStart, Clock::now()), postfix.length(),
+                              expressionMemory, parseMemory);
             cout << "> ";
         }
     }
-    return 0;
 }
 
+/**
+ * Reads whatever standard input has available, up to one chunk.  Unlike
+ * fread this returns as soon as any data arrives, so an interactive or
+ * slow pipe is answered line by line.
+ * @param data buffer of ChunkQueue::ChunkSize characters
+ * @return bytes read, 0 at end of input or on error
+ */
+static size_t ReadAvailable(char* data) {
+#ifdef _WIN32
+    int size = _read(0, data, ChunkQueue::ChunkSize);
+#else
+    ssize_t size;
+    do {
+        size = read(STDIN_FILENO, data, ChunkQueue::ChunkSize);
+    } while (size < 0 && errno == EINTR);
+#endif
+    return size < 0 ? 0 : (size_t) size;
+}
+
+/**
+ * Reads standard input in chunks of up to 64KB on a reader thread while this
+ * thread feeds them straight into a PostfixBuilder, so reading overlaps
+ * parsing and no line is ever held in memory as a whole.  Since the text
+ * is not kept, postfix expressions are not echoed; comment and blank
+ * lines still are.
+ * @param driver options and statistics
+ */
+static void RunStream(Driver& driver) {
+    ChunkQueue queue;
+    std::thread reader([&queue] {
+        size_t size;
+        do {
+            Chunk* chunk = queue.AcquireEmpty();
+            size = ReadAvailable(chunk->data);
+            chunk->size = size;
+            queue.PushFull(chunk);
+        } while (size > 0);
+    });
+
+    PostfixBuilder builder(driver.limits, &driver.symbols);
+    MemoryCounter expressionMemory;
+    MemoryCounter parseMemory(&expressionMemory);
+    uint64_t parseNanos = 0;
+    size_t bytesIn = 0;
+    bool lineStart = true;
+    bool comment = false;
+    bool done = false;
+
+    cout << "> ";
+    while (!done) {
+        Chunk* chunk = queue.PopFull();
+        const char* data = chunk->data;
+        size_t size = chunk->size;
+        size_t position = 0;
+
+        // End of input finishes a last line that has no newline
+        if (size == 0) {
+            done = true;
+            if (lineStart) {
+                queue.ReturnEmpty(chunk);
+                break;
+            }
+            data = "\n";
+            size = 1;
+        }
+
+        while (position < size) {
+            if (lineStart) {
+                driver.lineNumber ++;
+                lineStart = false;
+                comment = data[position] == '#' || data[position] == '\n';
+                if (!comment) {
+                    driver.symbols.Clear();
+                }
+            }
+
+            const char* newline = static_cast<const char*>(memchr(data + position, '\n', size - position));
+            size_t end = newline == nullptr ? size : newline - data;
+            if (comment) {
+                cout.write(data + position, end - position);
+            }
+            else {
+                Clock::time_point feedStart = Clock::now();
+                {
+                    MemoryScope scope(driver.trackMemory ? &parseMemory : nullptr);
+                    builder.Feed(data + position, end - position);
+                }
+                parseNanos += Nanos(feedStart, Clock::now());
+                bytesIn += end - position;
+            }
+            if (newline == nullptr) {
+                break;
+            }
+            position = end + 1;
+            lineStart = true;
+
+            if (comment) {
+                cout << endl;
+                continue;
+            }
+            ExpressionTree expTree;
+            bool built;
+
+            Clock::time_point finishStart = Clock::now();
+            {
+                MemoryScope scope(driver.trackMemory ? &parseMemory : nullptr);
+                built = expTree.BuildExpressionTree(builder);
+                builder.Reset();
+            }
+            parseNanos += Nanos(finishStart, Clock::now());
+            ProcessExpression(driver, expTree, built, parseNanos, bytesIn, expressionMemory, parseMemory);
+            cout << "> ";
+
+            expressionMemory = MemoryCounter();
+            parseMemory = MemoryCounter(&expressionMemory);
+            parseNanos = 0;
+            bytesIn = 0;
+        }
+        if (!done) {
+            queue.ReturnEmpty(chunk);
+        }
+    }
+    reader.join();
+}
+
+int main(int argc, char* argv[]) {
+    Driver driver;
+    bool maxNodesSet = false;
+
+    for (int i = 1; i < argc; i ++) {
+        long value;
+        if (strcmp(argv[i], "--stats") == 0) { driver.showStats = true; }
+        else if (strcmp(argv[i], "--horner") == 0) { driver.optimize = true; }
+        else if (strcmp(argv[i], "--symbols") == 0) { driver.showSymbols = true; }
+        else if (strcmp(argv[i], "--memory") == 0) { driver.trackMemory = true; }
+        else if (strcmp(argv[i], "--stream") == 0) { driver.stream = true; }
+        else if (ParseOption(argv[i], "--stats-interval=", value)) { driver.statsInterval = value; }
+        else if (ParseOption(argv[i], "--max-nodes=", value)) { driver.limits.maxNodes = value; maxNodesSet = true; }
+        else if (ParseOption(argv[i], "--max-depth=", value)) { driver.limits.maxDepth = value; }
+        else if (ParseOption(argv[i], "--max-digits=", value)) { driver.limits.maxNumberDigits = value; }
+        else if (ParseOption(argv[i], "--max-token=", value)) { driver.limits.maxTokenLength = value; }
+        else if (ParseOption(argv[i], "--time-budget=", value)) { driver.limits.maxMilliseconds = value; }
+        else {
+            cerr << "usage: " << argv[0] << " [--stream] [--horner] [--symbols] [--memory] [--stats] [--stats-interval=N]"
+                 << " [--max-nodes=N] [--max-depth=N] [--max-digits=N] [--max-token=N] [--time-budget=MS]" << endl;
+            return 1;
+        }
+    }
+    // Streaming is meant for expressions too large to hold as text, so
+    // only the depth limit, which protects the recursive passes, applies
+    if (driver.stream && !maxNodesSet) {
+        driver.limits.maxNodes = 0;
+    }
+    if (driver.trackMemory && !MemoryAccountingEnabled()) {
+        cerr << "warning: --memory ignored, configure with -DEXPRESSION_MEMORY_ACCOUNTING=ON to enable it" << endl;
+        driver.trackMemory = false;
+    }
+
+    driver.runStart = Clock::now();
+    if (driver.stream) {
+        RunStream(driver);
+    }
+    else {
+        RunLines(driver);
+    }
+
+    if (driver.showStats) {
+        driver.stats.WriteSummary(cerr, Seconds(driver.runStart, Clock::now()));
+    }
+    if (driver.trackMemory) {
+        cerr << "Peak expression memory: " << driver.maxPeakBytes << " bytes (line " << driver.maxPeakLine << ")" << endl;
+    }
+    return 0;
+}